@@ -0,0 +1,73 @@
+/* Automatic six-position calibration of the LSM9DS1 accelerometer
+ *
+ * Unlike DIY_Calibration_Accelerometer no keyboard input is needed. Put the board (preferably in a
+ * rectangular box) on a horizontal surface with one of its axes pointing up and keep it still for about
+ * a second. The led lights up for half a second when the position was taken. Then turn it to the next position.
+ * Each axis pointing up and pointing down gives six positions. As soon as four of them are done a
+ * least squares solution for offset, slope and cross-axis terms is printed, it is refined with every
+ * further position.
+ * The offset and slope are printed as code that can be copy/pasted directly into a sketch.
+ *
+ * This program uses V2 of the LSM9DS1 library
+ */
+
+#include <Arduino_LSM9DS1.h>
+
+uint8_t accelODRindex=3; // Sample Rate 0:off, 1:10Hz, 2:50Hz, 3:119Hz, 4:238Hz, 5:476Hz, (6:952Hz=na)
+uint8_t accelFSindex=0;  // Full Scale// 0: ±2g ; 1: ±24g ; 2: ±4g ; 3: ±8g
+char xyz[3]= {'X','Y','Z'};
+
+LSM9DS1AccelCalibrator calibrator;
+int lastMask = 0;
+const unsigned long ledOnTime = 500;   // ms
+unsigned long ledOnSince = 0;
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial);
+  pinMode(LED_BUILTIN,OUTPUT);
+  delay(10);
+  if (!IMU.begin()) { Serial.println(F("Failed to initialize IMU!")); while (1);  }
+  IMU.setAccelFS(accelFSindex);
+  IMU.setAccelODR(accelODRindex);
+  Serial.println(F("\n\n Place the board with one of its axes vertical and keep it still."));
+}
+
+void loop() {
+  float x, y, z;
+  if (millis() - ledOnSince >= ledOnTime) digitalWrite(LED_BUILTIN, LOW);
+  if (!IMU.accelAvailable()) return;
+  IMU.readRawAccel(x, y, z);
+  calibrator.addSample(x, y, z);
+
+  int mask = calibrator.orientationMask();
+  if (mask == lastMask) return;
+  lastMask = mask;
+  digitalWrite(LED_BUILTIN, HIGH);       // a new position was taken
+  ledOnSince = millis();
+
+  Serial.print(F("\n Measured status of axis \n "));
+  for (int i=0;i<=2;i++){  Serial.print(xyz[i]); if (bitRead(mask,i)==1)Serial.print("+ = ( -OK- ) "); else Serial.print("+ = not done "); }
+  Serial.print("\n ");
+  for (int i=0;i<=2;i++){  Serial.print(xyz[i]); if (bitRead(mask,i+3)==1)Serial.print("- = ( -OK- ) "); else Serial.print("- = not done "); }
+  Serial.println();
+
+  if (!calibrator.solve()) return;
+  calibrator.applyTo(IMU);
+  Serial.print(F("\n   // Accelerometer code   (fit error "));Serial.print(calibrator.residual,4);Serial.println(F(" g)"));
+  Serial.print(F("   IMU.setAccelFS(")); Serial.print(accelFSindex);
+  Serial.print(F(");\n   IMU.setAccelODR("));Serial.print(accelODRindex);Serial.println(");");
+  printSetParam("   IMU.setAccelOffset",IMU.accelOffset);
+  Serial.println();
+  printSetParam("   IMU.setAccelSlope ",IMU.accelSlope);
+  Serial.println(F("\n\n   // Cross-axis correction matrix, apply with calibrator.correct()"));
+  for (int i=0;i<=2;i++) { printSetParam("   ",calibrator.matrix[i]); Serial.println(); }
+  if (calibrator.isComplete()) Serial.println(F("\n All six positions done."));
+}
+
+void printSetParam(const char txt[], float param[3])
+{   Serial.print(txt);Serial.print("(");
+    Serial.print(param[0],6);Serial.print(", ");
+    Serial.print(param[1],6);Serial.print(", ");
+    Serial.print(param[2],6);Serial.print(");");
+}
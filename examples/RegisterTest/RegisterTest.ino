@@ -46,6 +46,7 @@ void setup() {
    testAccelSharedODR();
    testAccelOnlyODR();
    testMagnetODR();
+   testMagnetPerformance();
    testAccelAutomaticBW();
    testAccelBWOverride();
    testGyroBW();   
@@ -165,6 +166,19 @@ void testMagnetODR()
   }
 }
 
+void testMagnetPerformance()
+{  Serial.println(F("\n setMagnetFastODR performance mode, sample rate and noise (keep the board still)"));
+  for (int i = 0;i<=4;i++)
+  {    if (IMU.setMagnetFastODR(i))
+       {  printResult ("setMagnetFastODR(", i , IMU.getMagnetODR()," Hz ");
+          Serial.print(F(" noise "));Serial.print(IMU.measureMagnetNoise(100),3);Serial.println(F(" uT"));
+       }
+      else {Serial.print (F("setMagnetFastODR  parameter out of range "));Serial.println(i);}
+  }
+  IMU.setMagnetPerformance(MAGNET_MEDIUM, MAGNET_MEDIUM);   // restore default
+  IMU.setMagnetODR(6);
+}
+
 //---------------------------------  BW (Band width)  functions  -------------------------------
 void testAccelAutomaticBW()
 { Serial.println(F("\n Accelerometer automatic band width result ")); 
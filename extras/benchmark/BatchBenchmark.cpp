@@ -0,0 +1,74 @@
+/* Host microbenchmark: per sample conversion (as in readRawAccel + readAccel) against
+ * the batch conversion of LSM9DS1ConvertBatch().
+ *
+ * Build and run on a PC from this folder:
+ *   g++ -O2 -I../../src BatchBenchmark.cpp ../../src/LSM9DS1_Batch.cpp -o BatchBenchmark
+ *   ./BatchBenchmark
+ *
+ * Only the arithmetic is measured. On the board the scalar path also reads the full scale
+ * register over I2C for every sample, the batch path once per batch.
+ */
+
+#include "LSM9DS1_Batch.h"
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+const size_t samples = 4096;   // one batch, fits in cache like a FIFO drain would
+const int    repeats = 2000;
+
+float fullScale = 4.0;
+float unit = 1.0;
+float slope[3]  = {1.01, 0.99, 1.02};
+float offset[3] = {0.012, -0.020, 0.031};
+
+// Same math as readRawAccel() followed by readAccel(), one sample per call
+__attribute__((noinline)) void convertScalar(const int16_t data[3], float& x, float& y, float& z)
+{ float scale = fullScale / 32768.0;
+  x = scale * data[0];
+  y = scale * data[1];
+  z = scale * data[2];
+  x = unit * slope[0] * (x - offset[0]);
+  y = unit * slope[1] * (y - offset[1]);
+  z = unit * slope[2] * (z - offset[2]);
+}
+
+template <class F> double samplesPerSecond(F run)
+{ auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < repeats; r++) run();
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return samples * (double)repeats / elapsed.count();
+}
+
+int main()
+{ std::vector<int16_t> raw(3 * samples);
+  for (size_t i = 0; i < raw.size(); i++) raw[i] = (int16_t)(rand() - RAND_MAX / 2);
+  std::vector<float> sx(samples), sy(samples), sz(samples);
+  std::vector<float> bx(samples), by(samples), bz(samples);
+
+  float gain[3], bias[3];
+  for (int i = 0; i < 3; i++)
+  { gain[i] = unit * slope[i] * fullScale / 32768.0;
+    bias[i] = -unit * slope[i] * offset[i];
+  }
+
+  double scalar = samplesPerSecond([&]() {
+    for (size_t i = 0; i < samples; i++) convertScalar(&raw[3 * i], sx[i], sy[i], sz[i]);
+  });
+  double batch = samplesPerSecond([&]() {
+    LSM9DS1ConvertBatch(raw.data(), samples, gain, bias, bx.data(), by.data(), bz.data());
+  });
+
+  float maxDiff = 0;
+  for (size_t i = 0; i < samples; i++)
+  { maxDiff = fmaxf(maxDiff, fabsf(sx[i] - bx[i]));
+    maxDiff = fmaxf(maxDiff, fabsf(sy[i] - by[i]));
+    maxDiff = fmaxf(maxDiff, fabsf(sz[i] - bz[i]));
+  }
+  printf("scalar : %12.0f samples/s\n", scalar);
+  printf("batch  : %12.0f samples/s  (%.1fx)\n", batch, batch / scalar);
+  printf("max difference %g\n", maxDiff);
+  return maxDiff < 1e-5 ? 0 : 1;
+}
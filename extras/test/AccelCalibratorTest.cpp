@@ -0,0 +1,78 @@
+/* Host test of LSM9DS1AccelCalibrator with synthetic data.
+ *
+ * Build and run on a PC from this folder:
+ *   g++ -O2 -I../../src AccelCalibratorTest.cpp ../../src/LSM9DS1_AccelCalibrator.cpp -o AccelCalibratorTest
+ *   ./AccelCalibratorTest
+ *
+ * A known distortion raw = C * g + b plus noise is fed as still windows in all six orientations,
+ * with moving samples in between.
+ */
+
+#include "LSM9DS1_AccelCalibrator.h"
+#include "check.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+const float C[3][3] = {{ 1.02,  0.01, -0.02},
+                       { 0.015, 0.97,  0.01},
+                       {-0.01,  0.02,  1.05}};
+const float b[3] = {0.03, -0.02, 0.05};
+
+float noise(float amplitude)
+{ return amplitude * (rand() / (float)RAND_MAX - 0.5);
+}
+
+void feedStill(LSM9DS1AccelCalibrator& cal, int orientation, int samples)
+{ float g[3] = {0, 0, 0};
+  g[orientation % 3] = orientation < 3 ? 1 : -1;
+  for (int i = 0; i < samples; i++)
+  { float r[3];
+    for (int a = 0; a < 3; a++) r[a] = b[a] + C[a][0] * g[0] + C[a][1] * g[1] + C[a][2] * g[2] + noise(0.005);
+    cal.addSample(r[0], r[1], r[2]);
+  }
+}
+
+void feedMoving(LSM9DS1AccelCalibrator& cal, int samples)
+{ for (int i = 0; i < samples; i++) cal.addSample(sin(i * 0.3), cos(i * 0.2), 0.5 + noise(0.5));
+}
+
+int main()
+{ LSM9DS1AccelCalibrator cal;
+  const int order[6] = {0, 4, 2, 3, 1, 5};   // X+ Y- Z+ X- Y+ Z-
+  srand(1);
+
+  feedMoving(cal, 200);
+  check(cal.orientationMask() == 0, "moving samples are not accepted");
+
+  for (int k = 0; k < 6; k++)
+  { feedStill(cal, order[k], 150);
+    feedMoving(cal, 60);
+    check(cal.orientationMask() & (1 << order[k]), "still orientation detected");
+    if (k == 2) check(!cal.isReady(), "not ready after three orientations");
+    if (k == 3) check(cal.isReady() && !cal.isComplete(), "ready after four orientations");
+  }
+  check(cal.isComplete(), "complete after six orientations");
+  check(cal.solve(), "solve");
+
+  float maxBias = 0, maxIdentity = 0;
+  for (int r = 0; r < 3; r++)
+  { maxBias = fmax(maxBias, fabs(cal.bias[r] - b[r]));
+    for (int c = 0; c < 3; c++)
+    { float mc = 0;
+      for (int k = 0; k < 3; k++) mc += cal.matrix[r][k] * C[k][c];
+      maxIdentity = fmax(maxIdentity, fabs(mc - (r == c ? 1 : 0)));
+    }
+  }
+  printf("      bias error %g  |M*C - I| %g  residual %g\n", maxBias, maxIdentity, cal.residual);
+  check(maxBias < 1e-3, "bias");
+  check(maxIdentity < 1e-3, "M * C = I");
+  check(cal.residual < 1e-3, "residual");
+
+  float x = b[0] + C[0][1], y = b[1] + C[1][1], z = b[2] + C[2][1];   // Y+ without noise
+  cal.correct(x, y, z);
+  check(fabs(x) < 1e-3 && fabs(y - 1) < 1e-3 && fabs(z) < 1e-3, "correct() gives 1 g along Y");
+
+  printf("%d failures\n", failures);
+  return failures;
+}
@@ -0,0 +1,100 @@
+/* Host test of bus error recovery and the health monitor against a fault injecting mock bus.
+ *
+ * Build and run on a PC from this folder:
+ *   g++ -O2 -Imock -I../../src BusRecoveryTest.cpp mock/MockArduino.cpp ../../src/LSM9DS1*.cpp -o BusRecoveryTest
+ *   ./BusRecoveryTest
+ */
+
+#include "LSM9DS1.h"
+#include "check.h"
+
+void setAccelData(int16_t x, int16_t y, int16_t z)
+{ int16_t data[3] = {x, y, z};
+  memcpy(&Wire.registers[0][0x28], data, sizeof(data));
+}
+
+int main()
+{ float x, y, z;
+  unsigned long start, stall;
+
+  check(IMU.begin(), "begin");
+  setAccelData(0x4000, 0, 0);                                 // 0.5 full scale = 2 g at the default 4 g
+
+  // a single NACK is recovered transparently
+  IMU.resetHealth();
+  Wire.failNext = 1;
+  start = micros();
+  int ok = IMU.readAccel(x, y, z);
+  stall = micros() - start;
+  printf("      single NACK: read took %lu us\n", stall);
+  check(ok && x == 2.0, "single NACK: data read");
+  check(IMU.health.busErrors == 1 && IMU.health.recoveries == 1, "single NACK: counted as recovered");
+  check(IMU.lastError() == LSM9DS1_ERROR_NONE && IMU.healthStatus() == 0, "single NACK: healthy afterwards");
+
+  // a dead bus gives NAN within the time budget
+  delay(10);                                                  // start with a fresh budget
+  Wire.dead = true;
+  start = micros();
+  ok = IMU.readAccel(x, y, z);
+  stall = micros() - start;
+  printf("      dead bus: read took %lu us, budget %lu us\n", stall, IMU.recoveryTimeout);
+  check(!ok && isnan(x) && isnan(y) && isnan(z), "dead bus: NAN");
+  check(IMU.lastError() == LSM9DS1_ERROR_RECOVERY, "dead bus: LSM9DS1_ERROR_RECOVERY");
+  check(IMU.health.failedRecoveries >= 1 && IMU.health.nanSamples == 1, "dead bus: counted");
+  check(IMU.healthStatus() & LSM9DS1_HEALTH_BUS_ERROR, "dead bus: LSM9DS1_HEALTH_BUS_ERROR");
+  check(stall <= IMU.recoveryTimeout + 1000, "dead bus: stall within budget plus one transfer");
+  check(isnan(IMU.getAccelFS()), "dead bus: getAccelFS() is NAN");
+  check(IMU.getOperationalMode() == -1 && IMU.setAccelODR(3) == 0 && IMU.setGyroODR(3) == 0,
+        "dead bus: ODR setters fail");
+  Wire.dead = false;
+  check(IMU.recoverBus(), "dead bus: manual recovery right after the budget ran out");
+
+  // manual recovery with automatic recovery turned off
+  IMU.recoveryTimeout = 0;
+  unsigned long begins = Wire.begins;
+  Wire.failNext = 1;
+  check(!IMU.readAccel(x, y, z) && Wire.begins == begins, "recoveryTimeout 0: no automatic recovery");
+  check(IMU.recoverBus() && IMU.lastError() == LSM9DS1_ERROR_NONE, "recoveryTimeout 0: manual recovery");
+  check(IMU.readAccel(x, y, z) && x == 2.0, "recoveryTimeout 0: data read after manual recovery");
+  IMU.recoveryTimeout = LSM9DS1_RECOVERY_TIMEOUT;
+
+  // wiped control registers (brown out of the chip) are written back
+  delay(10);
+  uint8_t accelGyro[0x20], magnet[4];
+  memcpy(accelGyro, &Wire.registers[0][0x10], sizeof(accelGyro));
+  memcpy(magnet, &Wire.registers[1][0x20], sizeof(magnet));
+  memset(&Wire.registers[0][0x10], 0, 0x20);
+  memset(&Wire.registers[1][0x20], 0, 4);
+  Wire.begin();                                               // restores WHO_AM_I and status
+  setAccelData(0x4000, 0, 0);
+  Wire.failNext = 1;
+  ok = IMU.readGyro(x, y, z);
+  check(ok, "wiped registers: read after recovery");
+  check(Wire.registers[0][0x10] == accelGyro[0] && Wire.registers[0][0x20] == accelGyro[0x10]
+        && Wire.registers[0][0x23] == accelGyro[0x13] && Wire.registers[0][0x2E] == accelGyro[0x1E],
+        "wiped registers: accelerometer/gyroscope restored");
+  check(Wire.registers[1][0x20] == magnet[0] && Wire.registers[1][0x21] == (magnet[1] & 0x60)
+        && Wire.registers[1][0x22] == magnet[2] && Wire.registers[1][0x23] == magnet[3],
+        "wiped registers: magnetometer restored");
+
+  // stuck and saturated samples
+  IMU.resetHealth();
+  for (int i = 0; i < IMU.stuckLimit; i++)
+  { setAccelData(i, -i, 100);
+    IMU.readAccel(x, y, z);
+  }
+  check(!(IMU.healthStatus() & LSM9DS1_HEALTH_ACCEL_STUCK), "changing samples: not stuck");
+  for (int i = 0; i <= IMU.stuckLimit; i++) IMU.readAccel(x, y, z);
+  check(IMU.healthStatus() & LSM9DS1_HEALTH_ACCEL_STUCK, "identical samples: LSM9DS1_HEALTH_ACCEL_STUCK");
+  check(IMU.health.stuckSamples > 0, "identical samples: counted");
+  setAccelData(32767, 0, 0);
+  IMU.readAccel(x, y, z);
+  check(IMU.healthStatus() & LSM9DS1_HEALTH_ACCEL_SATURATED, "full scale: LSM9DS1_HEALTH_ACCEL_SATURATED");
+  check(IMU.health.saturatedSamples == 1, "full scale: counted");
+  setAccelData(1000, 0, 0);
+  IMU.readAccel(x, y, z);
+  check(IMU.healthStatus() == 0, "normal sample: healthy again");
+
+  printf("%d failures\n", failures);
+  return failures;
+}
@@ -0,0 +1,125 @@
+/* Host test of saveConfig(), loadConfig() and begin(storage) through LSM9DS1FileStorage and the mock bus.
+ *
+ * Build and run on a PC from this folder:
+ *   g++ -O2 -Imock -I../../src ConfigStorageTest.cpp mock/MockArduino.cpp ../../src/LSM9DS1*.cpp -o ConfigStorageTest
+ *   ./ConfigStorageTest
+ */
+
+#include "LSM9DS1.h"
+#include "check.h"
+
+const char* path = "ConfigStorageTest.bin";
+
+uint16_t crc16(const uint8_t* data, size_t length)      // CRC-16/CCITT-FALSE, as in the library
+{ uint16_t crc = 0xFFFF;
+  while (length--)
+  { crc ^= (uint16_t)*data++ << 8;
+    for (int i = 0; i < 8; i++) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+void writeFile(const uint8_t* data, size_t length)
+{ LSM9DS1FileStorage file(path);
+  file.write(data, length);
+}
+
+void wipeRegisters()
+{ memset(&Wire.registers[0][0x10], 0, 0x20);
+  memset(&Wire.registers[1][0x20], 0, 4);
+}
+
+bool sameArray(const float* a, const float* b)
+{ return a[0] == b[0] && a[1] == b[1] && a[2] == b[2];
+}
+
+// A rejected blob must not change the settings, begin(storage) must then run the full begin()
+void checkRejected(const uint8_t* data, size_t length, const char* what)
+{ char text[80];
+  writeFile(data, length);
+  LSM9DS1FileStorage file(path);
+  uint8_t before[LSM9DS1_CONFIG_SIZE], after[LSM9DS1_CONFIG_SIZE];
+  IMU.serializeConfig(before, sizeof(before));
+  snprintf(text, sizeof(text), "%s: loadConfig() fails", what);
+  check(!IMU.loadConfig(file), text);
+  IMU.serializeConfig(after, sizeof(after));
+  snprintf(text, sizeof(text), "%s: state unchanged", what);
+  check(memcmp(before, after, sizeof(before)) == 0, text);
+
+  wipeRegisters();
+  unsigned long start = micros();
+  int ok = IMU.begin(file);
+  unsigned long boot = micros() - start;
+  printf("      %s: begin(storage) took %lu us\n", what, boot);
+  snprintf(text, sizeof(text), "%s: begin(storage) falls back to begin()", what);
+  check(ok && boot > 250000 && Wire.registers[0][0x10] == 0x78 && Wire.registers[0][0x20] == 0x70, text);
+}
+
+int main()
+{ check(IMU.begin(), "begin");
+  IMU.setAccelFS(3);
+  IMU.setGyroFS(1);
+  IMU.setMagnetFS(2);
+  IMU.setMagnetODR(5);
+  IMU.setContinuousMode();
+  IMU.setAccelOffset(0.01, -0.02, 0.03);
+  IMU.setAccelSlope(1.01, 0.98, 1.02);
+  IMU.setGyroOffset(0.5, -0.6, 0.7);
+  IMU.setGyroSlope(1.1, 0.9, 1.05);
+  IMU.setMagnetOffset(10, -20, 30);
+  IMU.setMagnetSlope(1.2, 0.8, 1.15);
+  IMU.accelUnit = METERPERSECOND2;
+  IMU.gyroUnit = RADIANSPERSECOND;
+  IMU.magnetUnit = NANOTESLA;
+
+  LSM9DS1FileStorage file(path);
+  check(IMU.saveConfig(file), "saveConfig");
+  uint8_t accelGyro[0x20], magnet[4];
+  memcpy(accelGyro, &Wire.registers[0][0x10], sizeof(accelGyro));
+  memcpy(magnet, &Wire.registers[1][0x20], sizeof(magnet));
+
+  // round trip into a fresh instance, on a chip that lost its settings
+  wipeRegisters();
+  LSM9DS1Class restored(Wire);
+  unsigned long start = micros();
+  check(restored.begin(file), "begin(storage)");
+  unsigned long boot = micros() - start;
+  printf("      begin(storage) took %lu us\n", boot);
+  check(boot < 250000, "begin(storage) skips measureODRcombined()");
+  check(Wire.registers[0][0x10] == accelGyro[0] && Wire.registers[0][0x20] == accelGyro[0x10],
+        "accelerometer/gyroscope registers restored");
+  check(memcmp(&Wire.registers[1][0x20], magnet, sizeof(magnet)) == 0, "magnetometer registers restored");
+  check(Wire.registers[0][0x23] == 0x02 && Wire.registers[0][0x2E] == 0xC0, "continuous mode restored");
+  check(restored.getAccelFS() == 8.0 && restored.getGyroFS() == 500.0 && restored.getMagnetFS() == 1200.0,
+        "full scales restored");
+  check(restored.getAccelODR() == IMU.getAccelODR() && restored.getGyroODR() == IMU.getGyroODR()
+        && restored.getMagnetODR() == IMU.getMagnetODR(), "ODR values restored");
+  check(sameArray(restored.accelOffset, IMU.accelOffset) && sameArray(restored.accelSlope, IMU.accelSlope)
+        && sameArray(restored.gyroOffset, IMU.gyroOffset) && sameArray(restored.gyroSlope, IMU.gyroSlope)
+        && sameArray(restored.magnetOffset, IMU.magnetOffset) && sameArray(restored.magnetSlope, IMU.magnetSlope),
+        "offsets and slopes restored");
+  check(restored.accelUnit == IMU.accelUnit && restored.gyroUnit == IMU.gyroUnit
+        && restored.magnetUnit == IMU.magnetUnit, "units restored");
+
+  // damaged files
+  uint8_t blob[LSM9DS1_CONFIG_SIZE];
+  check(IMU.serializeConfig(blob, sizeof(blob)) == sizeof(blob), "serializeConfig");
+  uint8_t damaged[LSM9DS1_CONFIG_SIZE];
+
+  memcpy(damaged, blob, sizeof(blob));
+  damaged[40] ^= 0x01;
+  checkRejected(damaged, sizeof(damaged), "flipped byte");
+
+  memcpy(damaged, blob, sizeof(blob));
+  damaged[2] = LSM9DS1_CONFIG_VERSION + 1;
+  uint16_t crc = crc16(damaged, sizeof(damaged) - 2);     // valid CRC, so only the version is wrong
+  damaged[sizeof(damaged) - 2] = crc & 0xFF;
+  damaged[sizeof(damaged) - 1] = crc >> 8;
+  checkRejected(damaged, sizeof(damaged), "wrong version");
+
+  checkRejected(blob, sizeof(blob) - 1, "short file");
+
+  remove(path);
+  printf("%d failures\n", failures);
+  return failures;
+}
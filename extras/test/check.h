@@ -0,0 +1,17 @@
+/* check() helper shared by the host tests in this folder.
+ * Every check prints pass or FAIL; a test returns the number of failed checks as its exit code.
+ */
+
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+static int failures = 0;
+
+static void check(bool ok, const char* what)
+{ printf("%s  %s\n", ok ? "pass" : "FAIL", what);
+  if (!ok) failures++;
+}
+
+#endif
@@ -0,0 +1,31 @@
+/* Minimal Arduino.h for building the library on a PC, see extras/test */
+
+#ifndef MOCK_ARDUINO_H
+#define MOCK_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include <string.h>
+#include <stdlib.h>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH   1
+#define LOW    0
+#define INPUT  0
+#define OUTPUT 1
+#define SDA    20
+#define SCL    21
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+
+unsigned long micros();
+unsigned long millis();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int  digitalRead(uint8_t pin);
+
+#endif
@@ -0,0 +1,70 @@
+/* Implementation of the Arduino.h and Wire.h mocks, see extras/test */
+
+#include "Arduino.h"
+#include "Wire.h"
+
+static unsigned long now = 0;      // simulated µs
+
+static void elapse(unsigned long us) { now += us; }
+
+unsigned long micros() { return ++now; }
+unsigned long millis() { return micros() / 1000; }
+void delay(unsigned long ms) { elapse(ms * 1000); }
+void delayMicroseconds(unsigned int us) { elapse(us); }
+void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t, uint8_t) {}
+int  digitalRead(uint8_t) { return HIGH; }
+
+const unsigned long byteTime = 90;   // 9 clocks at 100 kHz
+
+void TwoWire::begin()
+{ begins++;
+  registers[0][0x0f] = 0x68;         // WHO_AM_I
+  registers[1][0x0f] = 0x3d;
+  registers[0][0x17] = 0x03;         // STATUS_REG: accel and gyro data available
+  registers[1][0x27] = 0x08;         // STATUS_REG_M: XYZ data available
+}
+
+void TwoWire::end() {}
+
+void TwoWire::beginTransmission(uint8_t address)
+{ slave = address == 0x6b ? 0 : address == 0x1e ? 1 : -1;
+  written = 0;
+  elapse(byteTime);
+}
+
+size_t TwoWire::write(uint8_t value)
+{ elapse(byteTime);
+  if (written++ == 0) pointer = value & 0x7f;              // sub address, bit 7 = auto increment
+  else if (slave >= 0) registers[slave][pointer++] = value;
+  return 1;
+}
+
+bool TwoWire::fail()
+{ if (dead) return true;
+  if (failNext > 0) { failNext--; return true; }
+  return slave < 0;
+}
+
+uint8_t TwoWire::endTransmission(bool)
+{ return fail() ? 2 : 0;                                    // 2 = NACK on address
+}
+
+size_t TwoWire::requestFrom(uint8_t address, size_t length, bool)
+{ slave = address == 0x6b ? 0 : address == 0x1e ? 1 : -1;
+  elapse(byteTime * (length + 1));
+  if (fail()) return 0;
+  pending = length;
+  return length;
+}
+
+int TwoWire::read()
+{ if (pending == 0) return -1;
+  pending--;
+  return registers[slave][pointer++];
+}
+
+int TwoWire::available() { return pending; }
+
+TwoWire Wire;
+TwoWire Wire1;
@@ -0,0 +1,39 @@
+/* Fault injecting TwoWire mock with the registers of both LSM9DS1 slaves, see extras/test
+ * Time only passes through bus traffic (about 90 µs per byte at 100 kHz), delay() and micros().
+ */
+
+#ifndef MOCK_WIRE_H
+#define MOCK_WIRE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+class TwoWire {
+  public:
+    void    begin();
+    void    end();
+    void    beginTransmission(uint8_t address);
+    size_t  write(uint8_t value);
+    uint8_t endTransmission(bool stop = true);
+    size_t  requestFrom(uint8_t address, size_t length, bool stop = true);
+    int     read();
+    int     available();
+
+    // test control
+    uint8_t registers[2][256];   // [0] = accelerometer/gyroscope 0x6b, [1] = magnetometer 0x1e
+    int     failNext = 0;        // number of following transfers that are not acknowledged
+    bool    dead = false;        // no transfer is acknowledged
+    unsigned long begins = 0;    // calls to begin()
+
+  private:
+    int     slave = -1;
+    uint8_t pointer = 0;
+    int     written = 0;
+    size_t  pending = 0;
+    bool    fail();
+};
+
+extern TwoWire Wire;
+extern TwoWire Wire1;
+
+#endif
@@ -21,5 +21,6 @@
 #define _LSM9DS1_H_
 
 #include "LSM9DS1.h"
+#include "LSM9DS1_AccelCalibrator.h"
 
 #endif
@@ -37,7 +37,10 @@
 #define LSM9DS1_OUT_X_G            0x18
 #define LSM9DS1_CTRL_REG6_XL       0x20
 #define LSM9DS1_CTRL_REG8          0x22
+#define LSM9DS1_CTRL_REG9          0x23
 #define LSM9DS1_OUT_X_XL           0x28
+#define LSM9DS1_FIFO_CTRL          0x2E
+#define LSM9DS1_FIFO_SRC           0x2F
 
 // magnetometer
 #define LSM9DS1_ADDRESS_M          0x1e
@@ -49,10 +52,32 @@
 #define LSM9DS1_STATUS_REG_M       0x27
 #define LSM9DS1_OUT_X_L_M          0x28
 
+// configuration blob
+#define LSM9DS1_CONFIG_MAGIC       0x394C     // "L9"
+#define LSM9DS1_CONFIG_HEADER      4          // magic, version, payload length
+#define LSM9DS1_CONFIG_PAYLOAD     (LSM9DS1_CONFIG_SIZE - LSM9DS1_CONFIG_HEADER - 2)
+
+
+// control registers that are written back after a bus recovery
+static const uint8_t shadowTable[8][2] = {
+  {LSM9DS1_ADDRESS,   LSM9DS1_CTRL_REG1_G}, {LSM9DS1_ADDRESS,   LSM9DS1_CTRL_REG6_XL},
+  {LSM9DS1_ADDRESS,   LSM9DS1_CTRL_REG9},   {LSM9DS1_ADDRESS,   LSM9DS1_FIFO_CTRL},
+  {LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG1_M}, {LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG2_M},
+  {LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG3_M}, {LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG4_M} };
 
 LSM9DS1Class::LSM9DS1Class(TwoWire& wire) :
-  continuousMode(false), _wire(&wire)
+  continuousMode(false), error(LSM9DS1_ERROR_NONE), recovering(false), recoveryStart(0), recoveryBudget(0), saturated(0), _wire(&wire)
 {
+#if defined(ARDUINO_ARDUINO_NANO33BLE)
+  setBusPins(PIN_WIRE_SDA1, PIN_WIRE_SCL1);
+#elif defined(PIN_WIRE_SDA)
+  setBusPins(PIN_WIRE_SDA, PIN_WIRE_SCL);
+#else
+  setBusPins(SDA, SCL);
+#endif
+  memset(shadowRegs, 0, sizeof(shadowRegs));
+  memset(lastSample, 0, sizeof(lastSample));
+  memset(sameCount, 0, sizeof(sameCount));
 }
 
 LSM9DS1Class::~LSM9DS1Class()
@@ -61,30 +86,12 @@ LSM9DS1Class::~LSM9DS1Class()
 
 int LSM9DS1Class::begin()
 {
-  _wire->begin();
-
-  // reset
-  writeRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG8, 0x05);
-  writeRegister(LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG2_M, 0x0c);
-
-  delay(10);
-
-  if (readRegister(LSM9DS1_ADDRESS, LSM9DS1_WHO_AM_I) != 0x68) {
-    end();
-
-    return 0;
-  }
-
-  if (readRegister(LSM9DS1_ADDRESS_M, LSM9DS1_WHO_AM_I) != 0x3d) {
-    end();
-
-    return 0;
-  }
+  if (!resetChip()) return 0;
 
   writeRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG1_G, 0x78); // 119 Hz, 2000 dps, 16 Hz BW
   writeRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG6_XL, 0x70); // 119 Hz, 4G
 
-  writeRegister(LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG1_M, 0b10111000); // Temperature compensation enable, medium performance, 40 Hz
+  writeRegister(LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG1_M, 0b10111000); // Temperature compensation enable, medium performance (MAGNET_MEDIUM), 40 Hz
 //  writeRegister(LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG1_M, 0xb4); // Temperature compensation enable, medium performance, 20 Hz
   writeRegister(LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG2_M, 0x00); // 4 Gauss
 //  writeRegister(LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG2_M, 0b01100000); // 16 Gauss
@@ -95,21 +102,30 @@ int LSM9DS1Class::begin()
   return 1;
 }
 
+// Fast boot: one read from storage replaces the default settings, the pasted calibration code
+// and the 250ms ODR measurement, because the measured ODR values are part of the blob.
+int LSM9DS1Class::begin(LSM9DS1Storage& storage)
+{ uint8_t data[LSM9DS1_CONFIG_SIZE];
+  if (storage.read(data, sizeof(data)) != sizeof(data) || !validConfig(data, sizeof(data))) return begin();
+  if (!resetChip()) return 0;
+  if (!deserializeConfig(data, sizeof(data))) return begin();
+  return 1;
+}
 
 void LSM9DS1Class::setContinuousMode() {
   // Enable FIFO (see docs https://www.st.com/resource/en/datasheet/DM00103319.pdf)
-  writeRegister(LSM9DS1_ADDRESS, 0x23, 0x02);
+  writeRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG9, 0x02);
   // Set continuous mode
-  writeRegister(LSM9DS1_ADDRESS, 0x2E, 0xC0);
+  writeRegister(LSM9DS1_ADDRESS, LSM9DS1_FIFO_CTRL, 0xC0);
 
   continuousMode = true;
 }
 
 void LSM9DS1Class::setOneShotMode() {
   // Disable FIFO (see docs https://www.st.com/resource/en/datasheet/DM00103319.pdf)
-  writeRegister(LSM9DS1_ADDRESS, 0x23, 0x00);
+  writeRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG9, 0x00);
   // Disable continuous mode
-  writeRegister(LSM9DS1_ADDRESS, 0x2E, 0x00);
+  writeRegister(LSM9DS1_ADDRESS, LSM9DS1_FIFO_CTRL, 0x00);
  
   continuousMode = false;
 }
@@ -133,6 +149,131 @@ void LSM9DS1Class::end()
 #endif 
 }
 
+//************************************      Configuration storage      *****************************************
+
+static uint8_t* putFloat(uint8_t* p, float value)
+{ uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  for (int i = 0; i < 4; i++) *p++ = bits >> (8 * i);    // little endian on every platform
+  return p;
+}
+
+static const uint8_t* getFloat(const uint8_t* p, float& value)
+{ uint32_t bits = 0;
+  for (int i = 0; i < 4; i++) bits |= (uint32_t)*p++ << (8 * i);
+  memcpy(&value, &bits, sizeof(value));
+  return p;
+}
+
+// Blob layout (LSM9DS1_CONFIG_VERSION 1), little endian
+//   magic "L9" | version | payload length |
+//   CTRL_REG1_G CTRL_REG6_XL CTRL_REG1_M CTRL_REG2_M CTRL_REG3_M CTRL_REG4_M continuousMode |
+//   accelODR gyroODR magnetODR | accel, gyro, magnet Offset[3] Slope[3] | accel, gyro, magnet Unit |
+//   CRC-16/CCITT over all preceding bytes
+size_t LSM9DS1Class::serializeConfig(uint8_t* data, size_t length)
+{ if (length < LSM9DS1_CONFIG_SIZE) return 0;
+  const uint8_t regs[6][2] = {
+    {LSM9DS1_ADDRESS,   LSM9DS1_CTRL_REG1_G}, {LSM9DS1_ADDRESS,   LSM9DS1_CTRL_REG6_XL},
+    {LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG1_M}, {LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG2_M},
+    {LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG3_M}, {LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG4_M} };
+  uint8_t* p = data;
+  *p++ = LSM9DS1_CONFIG_MAGIC & 0xFF;
+  *p++ = LSM9DS1_CONFIG_MAGIC >> 8;
+  *p++ = LSM9DS1_CONFIG_VERSION;
+  *p++ = LSM9DS1_CONFIG_PAYLOAD;
+  for (int i = 0; i < 6; i++)
+  { int value = readRegister(regs[i][0], regs[i][1]);
+    if (value < 0) return 0;
+    *p++ = value;
+  }
+  *p++ = continuousMode;
+  p = putFloat(p, accelODR);
+  p = putFloat(p, gyroODR);
+  p = putFloat(p, magnetODR);
+  for (int i = 0; i < 3; i++) p = putFloat(p, accelOffset[i]);
+  for (int i = 0; i < 3; i++) p = putFloat(p, accelSlope[i]);
+  for (int i = 0; i < 3; i++) p = putFloat(p, gyroOffset[i]);
+  for (int i = 0; i < 3; i++) p = putFloat(p, gyroSlope[i]);
+  for (int i = 0; i < 3; i++) p = putFloat(p, magnetOffset[i]);
+  for (int i = 0; i < 3; i++) p = putFloat(p, magnetSlope[i]);
+  p = putFloat(p, accelUnit);
+  p = putFloat(p, gyroUnit);
+  p = putFloat(p, magnetUnit);
+  uint16_t crc = crc16(data, p - data);
+  *p++ = crc & 0xFF;
+  *p++ = crc >> 8;
+  return p - data;
+}
+
+int LSM9DS1Class::deserializeConfig(const uint8_t* data, size_t length)
+{ if (!validConfig(data, length)) return 0;
+  const uint8_t* p = data + LSM9DS1_CONFIG_HEADER;
+  int ok = 1;
+  ok &= writeRegister(LSM9DS1_ADDRESS,   LSM9DS1_CTRL_REG1_G,  p[0]);
+  ok &= writeRegister(LSM9DS1_ADDRESS,   LSM9DS1_CTRL_REG6_XL, p[1]);
+  ok &= writeRegister(LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG1_M,  p[2]);
+  ok &= writeRegister(LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG2_M,  p[3]);
+  ok &= writeRegister(LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG3_M,  p[4]);
+  ok &= writeRegister(LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG4_M,  p[5]);
+  if (p[6]) setContinuousMode();
+  else      setOneShotMode();
+  p += 7;
+  p = getFloat(p, accelODR);
+  p = getFloat(p, gyroODR);
+  p = getFloat(p, magnetODR);
+  for (int i = 0; i < 3; i++) p = getFloat(p, accelOffset[i]);
+  for (int i = 0; i < 3; i++) p = getFloat(p, accelSlope[i]);
+  for (int i = 0; i < 3; i++) p = getFloat(p, gyroOffset[i]);
+  for (int i = 0; i < 3; i++) p = getFloat(p, gyroSlope[i]);
+  for (int i = 0; i < 3; i++) p = getFloat(p, magnetOffset[i]);
+  for (int i = 0; i < 3; i++) p = getFloat(p, magnetSlope[i]);
+  p = getFloat(p, accelUnit);
+  p = getFloat(p, gyroUnit);
+  p = getFloat(p, magnetUnit);
+  return ok;
+}
+
+int LSM9DS1Class::saveConfig(LSM9DS1Storage& storage)
+{ uint8_t data[LSM9DS1_CONFIG_SIZE];
+  size_t length = serializeConfig(data, sizeof(data));
+  if (length == 0) return 0;
+  return storage.write(data, length) == length;
+}
+
+int LSM9DS1Class::loadConfig(LSM9DS1Storage& storage)
+{ uint8_t data[LSM9DS1_CONFIG_SIZE];
+  if (storage.read(data, sizeof(data)) != sizeof(data)) return 0;
+  return deserializeConfig(data, sizeof(data));
+}
+
+//************************************      Batch conversion      *****************************************
+
+// Folds   Unit * Slope * (FS / 32768 * Data - Offset)   into   gain * Data + bias   per axis,
+// so the full scale is read once per batch instead of once per sample.
+static int convertBatch(float fullScale, float unit, const float slope[3], const float offset[3],
+                        const int16_t* raw, size_t count, float* x, float* y, float* z)
+{ if (isnan(fullScale)) return 0;
+  float gain[3], bias[3];
+  for (int i = 0; i < 3; i++)
+  { gain[i] = unit * slope[i] * fullScale / 32768.0;
+    bias[i] = -unit * slope[i] * offset[i];
+  }
+  LSM9DS1ConvertBatch(raw, count, gain, bias, x, y, z);
+  return 1;
+}
+
+int LSM9DS1Class::convertAccel(const int16_t* raw, size_t count, float* x, float* y, float* z)
+{ return convertBatch(getAccelFS(), accelUnit, accelSlope, accelOffset, raw, count, x, y, z);
+}
+
+int LSM9DS1Class::convertGyro(const int16_t* raw, size_t count, float* x, float* y, float* z)
+{ return convertBatch(getGyroFS(), gyroUnit, gyroSlope, gyroOffset, raw, count, x, y, z);
+}
+
+int LSM9DS1Class::convertMagnet(const int16_t* raw, size_t count, float* x, float* y, float* z)
+{ return convertBatch(getMagnetFS(), magnetUnit, magnetSlope, magnetOffset, raw, count, x, y, z);
+}
+
 //************************************      Acceleration      *****************************************
 
 int LSM9DS1Class::readAccel(float& x, float& y, float& z)  // return calibrated data in a unit of choise
@@ -146,11 +287,12 @@ int LSM9DS1Class::readAccel(float& x, float& y, float& z)  // return calibrated
 
 int LSM9DS1Class::readRawAccel(float& x, float& y, float& z)   // return raw uncalibrated data 
 { int16_t data[3];
-  if (!readRegisters(LSM9DS1_ADDRESS, LSM9DS1_OUT_X_XL, (uint8_t*)data, sizeof(data))) 
-  {  x = NAN;     y = NAN;     z = NAN;   return 0;
+  float scale =  getAccelFS()/32768.0 ;   
+  if (isnan(scale) || !readRegisters(LSM9DS1_ADDRESS, LSM9DS1_OUT_X_XL, (uint8_t*)data, sizeof(data))) 
+  {  x = NAN;     y = NAN;     z = NAN;   health.nanSamples++;   return 0;
   }
+  checkSample(0, data);
   // See releasenotes   	read =	Unit * Slope * (PFS / 32786 * Data - Offset )
-  float scale =  getAccelFS()/32768.0 ;   
   x = scale * data[0];
   y = scale * data[1];
   z = scale * data[2];
@@ -162,11 +304,13 @@ int LSM9DS1Class::accelAvailable()
 {
   if (continuousMode) {
     // Read FIFO_SRC. If any of the rightmost 8 bits have a value, there is data.
-    if (readRegister(LSM9DS1_ADDRESS, 0x2F) & 63) {
+    int fifo = readRegister(LSM9DS1_ADDRESS, LSM9DS1_FIFO_SRC);
+    if (fifo > 0 && (fifo & 63)) {
       return 1;
     }
   } else {
-    if (readRegister(LSM9DS1_ADDRESS, LSM9DS1_STATUS_REG) & 0x01) {
+    int status = readRegister(LSM9DS1_ADDRESS, LSM9DS1_STATUS_REG);
+    if (status > 0 && (status & 0x01)) {
       return 1;
     }
   }
@@ -196,9 +340,10 @@ void LSM9DS1Class::setAccelSlope(float x, float y, float z)
 //           Operational mode Accel + Gyro: write setting in CTRL_REG1_G, shared ODR 
 int LSM9DS1Class::setAccelODR(uint8_t range) //Sample Rate 0:off, 1:10Hz, 2:50Hz, 3:119Hz, 4:238Hz, 5:476Hz, 6:952Hz
 {  if (range >= 7) return 0;
-   uint8_t setting = ((readRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG6_XL) & 0b00011111) | (range << 5));
-   if (writeRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG6_XL,setting)==0) return 0; 
-   switch (getOperationalMode()) {
+   if (modifyRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG6_XL, 0b00011111, range << 5)==0) return 0; 
+   int mode = getOperationalMode();
+   if (mode < 0) return 0;
+   switch (mode) {
    case 0 :	{	accelODR=0;
 				gyroODR=0; 
 				break;
@@ -207,8 +352,7 @@ int LSM9DS1Class::setAccelODR(uint8_t range) //Sample Rate 0:off, 1:10Hz, 2:50Hz
 				gyroODR = 0;
 				break;
 			}	
-   case 2 :	{	setting = ((readRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG1_G) & 0b00011111) | (range << 5) );
-				writeRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG1_G,setting) ;
+   case 2 :	{	modifyRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG1_G, 0b00011111, range << 5);
 				accelODR=  measureAccelGyroODR();
 				gyroODR = accelODR;
 			}
@@ -225,15 +369,14 @@ float LSM9DS1Class::getAccelODR()
 
 float LSM9DS1Class::setAccelBW(uint8_t range) //0,1,2,3 Override autoBandwidth setting see doc.table 67
 {   if (range >=4) return 0;
-    uint8_t RegIs = readRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG6_XL) & 0b11111000;
-    RegIs = RegIs | 0b00000100 | (range & 0b00000011) ;
-    return writeRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG6_XL,RegIs) ;
+    return modifyRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG6_XL, 0b11111000, 0b00000100 | (range & 0b00000011));
 }
 
 float LSM9DS1Class::getAccelBW() //Bandwidth setting 0,1,2,3  see documentation table 67
 {   float autoRange[] ={0.0, 408.0, 408.0, 50.0, 105.0, 211.0, 408.0, 0.0 };
     float BWXLRange[] ={ 408.0, 211.0, 105.0, 50.0 };
-    uint8_t RegIs = readRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG6_XL);
+    int RegIs = readRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG6_XL);
+    if (RegIs < 0) return NAN;
     if (bitRead(RegIs,2))  return BWXLRange [RegIs & 0b00000011];    
     else return autoRange [ RegIs >> 5 ];
 }
@@ -241,14 +384,14 @@ float LSM9DS1Class::getAccelBW() //Bandwidth setting 0,1,2,3  see documentation
 int LSM9DS1Class::setAccelFS(uint8_t range) // 0: ±2g ; 1: ±16g ; 2: ±4g ; 3: ±8g  
 {	if (range >=4) return 0;
     range = (range & 0b00000011) << 3;
-	uint8_t setting = ((readRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG6_XL) & 0xE7) | range);
-	return writeRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG6_XL,setting) ;
+	return modifyRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG6_XL, 0xE7, range);
 }
 
 float LSM9DS1Class::getAccelFS() // Full scale dimensionless, but its value corresponds to g
 {   float ranges[] ={2.0, 24.0, 4.0, 8.0}; //g
-    uint8_t setting = (readRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG6_XL) & 0x18) >> 3;
-    return ranges[setting] ;
+    int setting = readRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG6_XL);
+    if (setting < 0) return NAN;
+    return ranges[(setting & 0x18) >> 3] ;
 }
 
 //************************************      Gyroscope      *****************************************
@@ -264,10 +407,11 @@ int LSM9DS1Class::readGyro(float& x, float& y, float& z)   // return calibrated
 
 int LSM9DS1Class::readRawGyro(float& x, float& y, float& z)   // return raw data for calibration purposes
 { int16_t data[3];
-  if (!readRegisters(LSM9DS1_ADDRESS, LSM9DS1_OUT_X_G, (uint8_t*)data, sizeof(data))) 
-  { x = NAN;     y = NAN;    z = NAN;   return 0;
-  }
   float scale = getGyroFS() / 32768.0;
+  if (isnan(scale) || !readRegisters(LSM9DS1_ADDRESS, LSM9DS1_OUT_X_G, (uint8_t*)data, sizeof(data))) 
+  { x = NAN;     y = NAN;    z = NAN;   health.nanSamples++;   return 0;
+  }
+  checkSample(1, data);
   x = scale * data[0];
   y = scale * data[1];
   z = scale * data[2];
@@ -275,7 +419,8 @@ int LSM9DS1Class::readRawGyro(float& x, float& y, float& z)   // return raw data
 }
 int LSM9DS1Class::gyroAvailable()
 {
-  if (readRegister(LSM9DS1_ADDRESS, LSM9DS1_STATUS_REG) & 0x02) {
+  int status = readRegister(LSM9DS1_ADDRESS, LSM9DS1_STATUS_REG);
+  if (status > 0 && (status & 0x02)) {
     return 1;
   }
   return 0;
@@ -300,8 +445,11 @@ void LSM9DS1Class::setGyroSlope(float x, float y, float z)
 
 int LSM9DS1Class::getOperationalMode() //0=off , 1= Accel only , 2= Gyro +Accel
 {
-  if ((readRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG6_XL) & 0b11100000) ==0 ) return 0;
-  if ((readRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG1_G)  & 0b11100000) ==0 ) return 1;
+  int accel = readRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG6_XL);
+  int gyro  = readRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG1_G);
+  if (accel < 0 || gyro < 0) return -1;
+  if ((accel & 0b11100000) ==0 ) return 0;
+  if ((gyro  & 0b11100000) ==0 ) return 1;
   else return 2;
 }
 
@@ -310,13 +458,13 @@ int LSM9DS1Class::getOperationalMode() //0=off , 1= Accel only , 2= Gyro +Accel
    
 int LSM9DS1Class::setGyroODR(uint8_t range) // 0:off, 1:10Hz, 2:50Hz, 3:119Hz, 4:238Hz, 5:476Hz, 6:952Hz
 {	if (range >= 7) return 0;
-	uint8_t setting = ((readRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG1_G) & 0b00011111) | (range << 5 ) );
-	writeRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG1_G,setting);	
+	if (modifyRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG1_G, 0b00011111, range << 5)==0) return 0;
     if (range > 0 )
-	{	setting = ((readRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG6_XL) & 0b00011111) | (range << 5));
-		writeRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG6_XL,setting); 
+	{	if (modifyRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG6_XL, 0b00011111, range << 5)==0) return 0;
 	}
-	switch (getOperationalMode()) {
+	int mode = getOperationalMode();
+	if (mode < 0) return 0;
+	switch (mode) {
 	case 0:	{	accelODR=0;							//off
 				gyroODR=0; 
 				break;
@@ -342,8 +490,7 @@ float LSM9DS1Class::getGyroODR()
 int LSM9DS1Class::setGyroBW(uint8_t range)
 {  if (range >=4) return 0;
    range = range & 0b00000011;
-   uint8_t setting = readRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG1_G) & 0b11111100;
-   return writeRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG1_G,setting | range) ;	
+   return modifyRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG1_G, 0b11111100, range) ;	
 }
 
 #define ODRrows 8
@@ -359,7 +506,8 @@ float BWtable[ ODRrows ][ BWcols ] =      // acc to  table 47 dataheet
           { 0,  0,  0,  0   }   };
 
 float LSM9DS1Class::getGyroBW()
-{  uint8_t setting = readRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG1_G) ;
+{  int setting = readRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG1_G) ;
+   if (setting < 0) return NAN;
    uint8_t ODR = setting >> 5;
    uint8_t BW = setting & 0b00000011;
    return BWtable[ODR][BW];
@@ -368,14 +516,14 @@ float LSM9DS1Class::getGyroBW()
 int LSM9DS1Class::setGyroFS(uint8_t range) // (0: 245 dps; 1: 500 dps; 2: 1000  dps; 3: 2000 dps)
 {  if (range >=4) return 0;
    range = (range & 0b00000011) << 3;	
-   uint8_t setting = ((readRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG1_G) & 0xE7) | range );
-   return writeRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG1_G,setting) ;
+   return modifyRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG1_G, 0xE7, range) ;
 }
 
 float LSM9DS1Class::getGyroFS() //   dimensionless, but its value defaults to deg/s
 { float Ranges[] ={245.0, 500.0, 1000.0, 2000.0}; //dps
-  uint8_t setting = (readRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG1_G) & 0x18) >> 3;
-  return Ranges[setting] ;
+  int setting = readRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG1_G);
+  if (setting < 0) return NAN;
+  return Ranges[(setting & 0x18) >> 3] ;
 }
 
 //************************************      Magnetic field      *****************************************
@@ -391,10 +539,11 @@ int LSM9DS1Class::readMagneticField(float& x, float& y, float& z)   // return ca
 // return raw data for calibration purposes
 int LSM9DS1Class::readRawMagnet(float& x, float& y, float& z)
 { int16_t data[3];
-  if (!readRegisters(LSM9DS1_ADDRESS_M, LSM9DS1_OUT_X_L_M, (uint8_t*)data, sizeof(data))) 
-  {  x = NAN;     y = NAN;      z = NAN;     return 0;
-  }
   float scale = getMagnetFS() / 32768.0;
+  if (isnan(scale) || !readRegisters(LSM9DS1_ADDRESS_M, LSM9DS1_OUT_X_L_M, (uint8_t*)data, sizeof(data))) 
+  {  x = NAN;     y = NAN;      z = NAN;     health.nanSamples++;     return 0;
+  }
+  checkSample(2, data);
   x = scale * data[0] ;
   y = scale * data[1] ;
   z = scale * data[2] ;
@@ -404,7 +553,8 @@ int LSM9DS1Class::readRawMagnet(float& x, float& y, float& z)
 
 int LSM9DS1Class::magneticFieldAvailable()
 { //return (readRegister(LSM9DS1_ADDRESS_M, LSM9DS1_STATUS_REG_M) & 0x08)==0x08;
-  if (readRegister(LSM9DS1_ADDRESS_M, LSM9DS1_STATUS_REG_M) & 0x08) {
+  int status = readRegister(LSM9DS1_ADDRESS_M, LSM9DS1_STATUS_REG_M);
+  if (status > 0 && (status & 0x08)) {
     return 1;
   }
   return 0;
@@ -436,21 +586,118 @@ int LSM9DS1Class::setMagnetFS(uint8_t range) // 0=400.0; 1=800.0; 2=1200.0 , 3=1
 
 float LSM9DS1Class::getMagnetFS() //   dimensionless, but its value defaults to µT
 { const float Ranges[] ={400.0, 800.0, 1200.0, 1600.0}; //
-  uint8_t setting = readRegister(LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG2_M)  >> 5;
-  return  Ranges[setting] ;
+  int setting = readRegister(LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG2_M);
+  if (setting < 0) return NAN;
+  return  Ranges[(setting >> 5) & 0b11] ;
 }
 
-int LSM9DS1Class::setMagnetODR(uint8_t range)  // range (0..8) = {0.625,1.25,2.5,5,10,20,40,80,400}Hz
-{ if (range >=16) return 0;
+// Nominal FAST_ODR rate per X,Y performance mode (datasheet table 111). These rates are above what
+// polling over I2C at 100 kHz can keep up with, so they are not measured.
+static const float magnetFastODR[4] = {1000.0, 560.0, 300.0, 155.0}; //Hz
+
+int LSM9DS1Class::setMagnetODR(uint8_t range)  // range (0..7) = {0.625,1.25,2.5,5,10,20,40,80}Hz, 8 = FAST_ODR
+{ if (range > MAGNET_FAST_ODR) return 0;
   uint8_t setting = ((range & 0b00000111) << 2) | ((range & 0b00001000) >> 2);  // bit 2..4 see table 111, bit 1 = FAST_ODR
-          setting = setting | (readRegister(LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG1_M) & 0b11100001) ;
-          writeRegister(LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG1_M,setting) ;	 
+  if (modifyRegister(LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG1_M, 0b11100001, setting)==0) return 0;
+  if (range == MAGNET_FAST_ODR)
+  { int reg1 = readRegister(LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG1_M);
+    if (reg1 < 0) return 0;
+    magnetODR = magnetFastODR[(reg1 >> 5) & 0b11];
+    return 1;
+  }
   uint16_t duration = 1750 / (range + 1);   // 1750,875,666,500,400,333,285,250,222  calculate measuring time
   magnetODR= measureMagnetODR(duration);    //measure the actual ODR value
+  return 1;
+}
+
+// CTRL_REG1_M bit 5..6 = OM (X and Y), CTRL_REG4_M bit 2..3 = OMZ.  With FAST_ODR the sample rate follows
+// the X,Y mode, so in that case the nominal rate of the new mode is taken.
+int LSM9DS1Class::setMagnetPerformance(uint8_t xy, uint8_t z)
+{ if (xy > MAGNET_ULTRA_HIGH || z > MAGNET_ULTRA_HIGH) return 0;
+  if (modifyRegister(LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG1_M, 0b10011111, xy << 5)==0) return 0;
+  if (modifyRegister(LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG4_M, 0b11110011, z << 2)==0) return 0;
+  int setting = readRegister(LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG1_M);
+  if (setting < 0) return 0;
+  if (setting & 0b00000010) magnetODR = magnetFastODR[xy];
+  return 1;
+}
+
+int LSM9DS1Class::getMagnetPerformance(uint8_t& xy, uint8_t& z)
+{ int reg1 = readRegister(LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG1_M);
+  int reg4 = readRegister(LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG4_M);
+  if (reg1 < 0 || reg4 < 0) return 0;
+  xy = (reg1 >> 5) & 0b11;
+  z  = (reg4 >> 2) & 0b11;
+  return 1;
+}
+
+int LSM9DS1Class::setMagnetFastODR(uint8_t mode)  // 0:1000Hz 1:560Hz 2:300Hz 3:155Hz
+{ if (mode > MAGNET_ULTRA_HIGH) return 0;
+  if (modifyRegister(LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG1_M, 0b10000001, (mode << 5) | 0b00000010)==0) return 0;
+  if (modifyRegister(LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG4_M, 0b11110011, mode << 2)==0) return 0;
+  magnetODR = magnetFastODR[mode];
+  return 1;
+}
+
+// Standard deviation of polled samples, averaged over the axes, in magnetUnit.
+// The full scale is read once, so a sample costs a status read and a 6 byte read. That is about 1.2 ms
+// at 100 kHz, so in the fastest FAST_ODR modes the sampling is bus limited and skips sensor samples.
+// This does not change the noise figure, only the time it takes. Gives up after twice the expected time.
+float LSM9DS1Class::measureMagnetNoise(uint16_t samples)
+{ if (samples < 2 || magnetODR <= 0) return NAN;
+  float fullScale = getMagnetFS();
+  if (isnan(fullScale)) return NAN;
+  float first[3], sum[3] = {0,0,0}, sumSq[3] = {0,0,0};
+  float gain[3];
+  for (int i = 0; i < 3; i++) gain[i] = magnetUnit * magnetSlope[i] * fullScale / 32768.0;
+  uint16_t count = 0;
+  float period = 1.0 / magnetODR;                         // s
+  if (period < 0.0015) period = 0.0015;                   // bus limited above ~600 Hz
+  unsigned long timeout = 2000000.0 * samples * period + 100000,
+                start = micros();
+  while (count < samples && (micros() - start) < timeout)
+  { int16_t data[3];
+    if (!magnetAvailable() || !readRegisters(LSM9DS1_ADDRESS_M, LSM9DS1_OUT_X_L_M, (uint8_t*)data, sizeof(data))) continue;
+    float v[3];
+    for (int i = 0; i < 3; i++) v[i] = gain[i] * data[i];   // the offset does not change the noise
+    if (count == 0) for (int i = 0; i < 3; i++) first[i] = v[i];
+    for (int i = 0; i < 3; i++)     // relative to the first sample, to keep float precision
+    { float d = v[i] - first[i];
+      sum[i] += d;
+      sumSq[i] += d * d;
+    }
+    count++;
+  }
+  if (count < 2) return NAN;
+  float variance = 0;
+  for (int i = 0; i < 3; i++) variance += (sumSq[i] - sum[i] * sum[i] / count) / (count - 1);
+  return sqrt(variance / 3);
+}
+
+// Tries the FAST_ODR modes from fast to quiet. The latency of the chosen mode is 1 / getMagnetODR(),
+// the nominal rate. Noise is measured over ODR / 20 samples, at least 30: about 80 ms at 1000 Hz up
+// to 200 ms at 155 Hz (100 kHz bus), 0.4 s when all modes are tried.
+// When no mode is quiet enough, or on a bus error, the previous settings and ODR are restored.
+int LSM9DS1Class::setMagnetFastestMode(float maxNoise)
+{ int reg1 = readRegister(LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG1_M);
+  int reg4 = readRegister(LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG4_M);
+  if (reg1 < 0 || reg4 < 0) return -1;
+  float previousODR = magnetODR;
+  for (uint8_t mode = MAGNET_LOW_POWER; mode <= MAGNET_ULTRA_HIGH; mode++)
+  { if (!setMagnetFastODR(mode)) break;
+    uint16_t samples = magnetODR / 20 + 2;
+    if (samples < 30) samples = 30;
+    float noise = measureMagnetNoise(samples);
+    if (noise <= maxNoise) return mode;
+  }
+  writeRegister(LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG1_M, reg1);
+  writeRegister(LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG4_M, reg4);
+  magnetODR = previousODR;
+  return -1;
 }
 
-float LSM9DS1Class::getMagnetODR()  // Output {0.625, 1.25, 2.5, 5.0, 10.0, 20.0, 40.0 , 80.0}; //Hz
-{ return magnetODR;                 // return previously measured value
+float LSM9DS1Class::getMagnetODR()  // Output {0.625, 1.25, 2.5, 5.0, 10.0, 20.0, 40.0, 80.0} Hz measured,
+{ return magnetODR;                 // or in FAST_ODR the nominal {1000, 560, 300, 155} Hz, see magnetFastODR
 //	const float ranges[] ={0.625, 1.25,2.5, 5.0, 10.0, 20.0, 40.0 , 80.0}; //Hz
 //  uint8_t setting = (readRegister(LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG1_M) & 0b00011100) >> 2;
 //  return ranges[setting];
@@ -534,50 +781,268 @@ float LSM9DS1Class::measureMagnetODR(unsigned long duration)
    return (1000000.0*float(count)/float(lastEventTime-start) );
 }
 
-int LSM9DS1Class::readRegister(uint8_t slaveAddress, uint8_t address)
+int LSM9DS1Class::resetChip()
 {
-  _wire->beginTransmission(slaveAddress);
-  _wire->write(address);
-  if (_wire->endTransmission() != 0) {
-    return -1;
+  clockOutBus();            // frees a bus left half way a transfer by a reset of the processor
+  _wire->begin();
+  recovering = true;        // no automatic recovery while the chip is being reset
+
+  // reset
+  writeRegister(LSM9DS1_ADDRESS, LSM9DS1_CTRL_REG8, 0x05);
+  writeRegister(LSM9DS1_ADDRESS_M, LSM9DS1_CTRL_REG2_M, 0x0c);
+
+  delay(10);
+
+  if (readRegister(LSM9DS1_ADDRESS, LSM9DS1_WHO_AM_I) != 0x68) {
+    end();
+    recovering = false;
+
+    return 0;
   }
 
-  if (_wire->requestFrom(slaveAddress, 1) != 1) {
-    return -1;
+  if (readRegister(LSM9DS1_ADDRESS_M, LSM9DS1_WHO_AM_I) != 0x3d) {
+    end();
+    recovering = false;
+
+    return 0;
   }
+  recovering = false;
+  resetHealth();
+  return 1;
+}
 
-  return _wire->read();
+int LSM9DS1Class::validConfig(const uint8_t* data, size_t length)
+{ if (length < LSM9DS1_CONFIG_SIZE) return 0;
+  if (data[0] != (LSM9DS1_CONFIG_MAGIC & 0xFF) || data[1] != (LSM9DS1_CONFIG_MAGIC >> 8)) return 0;
+  if (data[2] != LSM9DS1_CONFIG_VERSION || data[3] != LSM9DS1_CONFIG_PAYLOAD) return 0;
+  uint16_t crc = data[LSM9DS1_CONFIG_SIZE - 2] | (data[LSM9DS1_CONFIG_SIZE - 1] << 8);
+  return crc16(data, LSM9DS1_CONFIG_SIZE - 2) == crc;
 }
 
-int LSM9DS1Class::readRegisters(uint8_t slaveAddress, uint8_t address, uint8_t* data, size_t length)
-{
-  _wire->beginTransmission(slaveAddress);
-  _wire->write(0x80 | address);
-  if (_wire->endTransmission(false) != 0) {
-    return -1;
+uint16_t LSM9DS1Class::crc16(const uint8_t* data, size_t length)   // CRC-16/CCITT-FALSE
+{ uint16_t crc = 0xFFFF;
+  while (length--)
+  { crc ^= (uint16_t)*data++ << 8;
+    for (int i = 0; i < 8; i++) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
   }
+  return crc;
+}
 
-  if (_wire->requestFrom(slaveAddress, length) != length) {
-    return 0;
+//************************************      Bus errors and health      *****************************************
+
+int LSM9DS1Class::lastError()
+{ return error;
+}
+
+int LSM9DS1Class::healthStatus()
+{ int status = saturated;
+  for (int i = 0; i < 3; i++) if (sameCount[i] >= stuckLimit) status |= LSM9DS1_HEALTH_ACCEL_STUCK << i;
+  if (error != LSM9DS1_ERROR_NONE) status |= LSM9DS1_HEALTH_BUS_ERROR;
+  return status;
+}
+
+void LSM9DS1Class::resetHealth()
+{ memset(&health, 0, sizeof(health));
+  memset(sameCount, 0, sizeof(sameCount));
+  saturated = 0;
+  error = LSM9DS1_ERROR_NONE;
+  recoveryStart = 0;
+}
+
+void LSM9DS1Class::setBusPins(uint8_t sda, uint8_t scl)
+{ sdaPin = sda;
+  sclPin = scl;
+}
+
+// sensor 0 = accel, 1 = gyro, 2 = magnet
+void LSM9DS1Class::checkSample(int sensor, const int16_t data[3])
+{ bool same = true;
+  bool full = false;
+  for (int i = 0; i < 3; i++)
+  { if (data[i] != lastSample[sensor][i]) same = false;
+    if (data[i] == 32767 || data[i] == -32768) full = true;
+    lastSample[sensor][i] = data[i];
   }
+  if (!same) sameCount[sensor] = 0;
+  else if (sameCount[sensor] < stuckLimit) sameCount[sensor]++;
+  if (sameCount[sensor] >= stuckLimit) health.stuckSamples++;
+  if (full)
+  { saturated |= LSM9DS1_HEALTH_ACCEL_SATURATED << sensor;
+    health.saturatedSamples++;
+  }
+  else saturated &= ~(LSM9DS1_HEALTH_ACCEL_SATURATED << sensor);
+}
 
-  for (size_t i = 0; i < length; i++) {
-    *data++ = _wire->read();
+void LSM9DS1Class::busError(uint8_t code)
+{ error = code;
+  health.busErrors++;
+}
+
+// A slave that was interrupted half way a read keeps SDA low until it has clocked out its byte.
+// Up to 9 clock pulses release it, then a STOP condition resets the bus state of all slaves.
+void LSM9DS1Class::clockOutBus()
+{ _wire->end();
+  pinMode(sdaPin, INPUT);
+  pinMode(sclPin, OUTPUT);
+  for (int i = 0; i < 9 && digitalRead(sdaPin) == LOW; i++)
+  { digitalWrite(sclPin, LOW);
+    delayMicroseconds(5);
+    digitalWrite(sclPin, HIGH);
+    delayMicroseconds(5);
   }
+  pinMode(sdaPin, OUTPUT);          // STOP: SDA low to high while SCL is high
+  digitalWrite(sdaPin, LOW);
+  delayMicroseconds(5);
+  digitalWrite(sclPin, HIGH);
+  delayMicroseconds(5);
+  digitalWrite(sdaPin, HIGH);
+  delayMicroseconds(5);
+  pinMode(sdaPin, INPUT);
+  pinMode(sclPin, INPUT);
+}
 
+int LSM9DS1Class::shadowIndex(uint8_t slaveAddress, uint8_t address)
+{ for (int i = 0; i < 8; i++)
+    if (shadowTable[i][0] == slaveAddress && shadowTable[i][1] == address) return i;
+  return -1;
+}
+
+// The chip may have lost its settings by a brown out, so they are always written back.
+int LSM9DS1Class::restoreRegisters()
+{ for (int i = 0; i < 8; i++)
+  { uint8_t value = shadowRegs[i];
+    if (shadowTable[i][0] == LSM9DS1_ADDRESS_M && shadowTable[i][1] == LSM9DS1_CTRL_REG2_M)
+      value &= 0b01100000;          // never repeat a soft reset or reboot
+    if (recoveryExpired() || !writeRegister(shadowTable[i][0], shadowTable[i][1], value)) return 0;
+  }
   return 1;
 }
 
+// The deadline is checked before every transfer, so it is overrun by at most one transfer.
+int LSM9DS1Class::recoveryExpired()
+{ return (micros() - recoveryStart) >= recoveryBudget;
+}
+
+// Automatic recovery after a failed transfer. All automatic recoveries that start within the
+// current budget share it, so a read call that fails twice (e.g. on the full scale and on the
+// data registers) cannot stall twice as long.
+int LSM9DS1Class::autoRecover()
+{ if (recovering || recoveryTimeout == 0) return 0;
+  unsigned long now = micros();
+  if (recoveryStart == 0 || now - recoveryStart >= recoveryBudget)
+  { recoveryStart = now;
+    recoveryBudget = recoveryTimeout;
+  }
+  return recover();
+}
+
+// An explicit call always gets a budget of its own, also when automatic recovery is off or has
+// just used up its budget.
+int LSM9DS1Class::recoverBus()
+{ if (recovering) return 0;
+  recoveryStart = micros();
+  recoveryBudget = recoveryTimeout ? recoveryTimeout : LSM9DS1_RECOVERY_TIMEOUT;
+  return recover();
+}
+
+int LSM9DS1Class::recover()
+{ recovering = true;
+  int ok = 0;
+  while (!ok && !recoveryExpired())
+  { clockOutBus();
+    _wire->begin();
+    ok = !recoveryExpired() && readRegister(LSM9DS1_ADDRESS, LSM9DS1_WHO_AM_I) == 0x68
+      && !recoveryExpired() && readRegister(LSM9DS1_ADDRESS_M, LSM9DS1_WHO_AM_I) == 0x3d
+      && restoreRegisters();
+  }
+  recovering = false;
+  if (ok)
+  { health.recoveries++;
+    error = LSM9DS1_ERROR_NONE;
+  }
+  else
+  { health.failedRecoveries++;
+    error = LSM9DS1_ERROR_RECOVERY;
+  }
+  return ok;
+}
+
+// Return the register value 0..255, or -1 on a bus error. Unless recoveryTimeout is 0, a failed
+// transfer is followed by a bus recovery and one retry.
+int LSM9DS1Class::readRegister(uint8_t slaveAddress, uint8_t address)
+{
+  int attempt = 0;
+  do {
+    _wire->beginTransmission(slaveAddress);
+    _wire->write(address);
+    uint8_t status = _wire->endTransmission();
+    if (status != 0) {
+      busError(status);
+    } else if (_wire->requestFrom(slaveAddress, 1) != 1) {
+      busError(LSM9DS1_ERROR_SHORT_READ);
+    } else {
+      error = LSM9DS1_ERROR_NONE;
+      return _wire->read();
+    }
+  } while (attempt++ == 0 && autoRecover());
+
+  return -1;
+}
+
+// Return 1 on success, 0 on a bus error.
+int LSM9DS1Class::readRegisters(uint8_t slaveAddress, uint8_t address, uint8_t* data, size_t length)
+{
+  int attempt = 0;
+  do {
+    _wire->beginTransmission(slaveAddress);
+    _wire->write(0x80 | address);
+    uint8_t status = _wire->endTransmission(false);
+    if (status != 0) {
+      busError(status);
+    } else if (_wire->requestFrom(slaveAddress, length) != length) {
+      busError(LSM9DS1_ERROR_SHORT_READ);
+    } else {
+      for (size_t i = 0; i < length; i++) {
+        *data++ = _wire->read();
+      }
+      error = LSM9DS1_ERROR_NONE;
+      return 1;
+    }
+  } while (attempt++ == 0 && autoRecover());
+
+  return 0;
+}
+
+// Return 1 on success, 0 on a bus error.
 int LSM9DS1Class::writeRegister(uint8_t slaveAddress, uint8_t address, uint8_t value)
 {
-  _wire->beginTransmission(slaveAddress);
-  _wire->write(address);
-  _wire->write(value);
-  if (_wire->endTransmission() != 0) {
+  int attempt = 0;
+  do {
+    _wire->beginTransmission(slaveAddress);
+    _wire->write(address);
+    _wire->write(value);
+    uint8_t status = _wire->endTransmission();
+    if (status != 0) {
+      busError(status);
+    } else {
+      int i = shadowIndex(slaveAddress, address);
+      if (i >= 0) shadowRegs[i] = value;
+      error = LSM9DS1_ERROR_NONE;
+      return 1;
+    }
+  } while (attempt++ == 0 && autoRecover());
+
+  return 0;
+}
+
+// Read-modify-write: keep the bits of keep, or in value. Nothing is written when the read fails.
+int LSM9DS1Class::modifyRegister(uint8_t slaveAddress, uint8_t address, uint8_t keep, uint8_t value)
+{
+  int current = readRegister(slaveAddress, address);
+  if (current < 0) {
     return 0;
   }
-
-  return 1;
+  return writeRegister(slaveAddress, address, (current & keep) | value);
 }
 
 #ifdef ARDUINO_ARDUINO_NANO33BLE
@@ -55,6 +55,8 @@
 
 #include <Arduino.h>
 #include <Wire.h>
+#include "LSM9DS1_Storage.h"
+#include "LSM9DS1_Batch.h"
 #define GAUSS             0.01           
 #define MICROTESLA        1.0       // default
 #define NANOTESLA         1000.0  
@@ -65,25 +67,87 @@
 #define REVSPERMINUTE     60.0/360.0 
 #define REVSPERSECOND     1.0/360.0
 
+// Magnetometer operating modes, more performance = more internal averaging = less noise, slower FAST_ODR
+#define MAGNET_LOW_POWER    0   // FAST_ODR 1000 Hz
+#define MAGNET_MEDIUM       1   // FAST_ODR  560 Hz   (begin() default)
+#define MAGNET_HIGH         2   // FAST_ODR  300 Hz
+#define MAGNET_ULTRA_HIGH   3   // FAST_ODR  155 Hz
+#define MAGNET_FAST_ODR     8   // setMagnetODR(8): rate set by the performance mode
+
+#define LSM9DS1_RECOVERY_TIMEOUT  5000  // µs, default time budget of a bus recovery
+
+#define LSM9DS1_CONFIG_VERSION  1
+#define LSM9DS1_CONFIG_SIZE     109   // bytes in a serialized configuration blob
+
+// lastError() codes, 1..5 are the codes of Wire.endTransmission()
+#define LSM9DS1_ERROR_NONE          0
+#define LSM9DS1_ERROR_TOO_LONG      1   // data too long for the transmit buffer
+#define LSM9DS1_ERROR_ADDRESS_NACK  2   // NACK on transmit of the slave address
+#define LSM9DS1_ERROR_DATA_NACK     3   // NACK on transmit of data
+#define LSM9DS1_ERROR_BUS           4   // other bus error
+#define LSM9DS1_ERROR_TIMEOUT       5   // bus timeout (cores that support it)
+#define LSM9DS1_ERROR_SHORT_READ    6   // fewer bytes received than requested
+#define LSM9DS1_ERROR_RECOVERY      7   // bus recovery did not succeed within the time budget
+
+// healthStatus() bits, 0 = healthy
+#define LSM9DS1_HEALTH_ACCEL_STUCK      0x01
+#define LSM9DS1_HEALTH_GYRO_STUCK       0x02
+#define LSM9DS1_HEALTH_MAGNET_STUCK     0x04
+#define LSM9DS1_HEALTH_ACCEL_SATURATED  0x08
+#define LSM9DS1_HEALTH_GYRO_SATURATED   0x10
+#define LSM9DS1_HEALTH_MAGNET_SATURATED 0x20
+#define LSM9DS1_HEALTH_BUS_ERROR        0x40
+
+struct LSM9DS1Health {
+  unsigned long busErrors;         // failed transfers
+  unsigned long recoveries;        // successful bus recoveries
+  unsigned long failedRecoveries;  // recoveries that ran out of time
+  unsigned long nanSamples;        // reads that returned NAN
+  unsigned long saturatedSamples;  // samples with an axis at full scale
+  unsigned long stuckSamples;      // samples identical to the previous stuckLimit samples
+};
+
 class LSM9DS1Class {
   public:
     LSM9DS1Class(TwoWire& wire);
     virtual ~LSM9DS1Class();
 
     int begin();
+    int begin(LSM9DS1Storage& storage); // Restore stored settings, skips the ODR measurement. Falls back to begin()
     void end();
 
+    // Store chip settings, measured ODR values, calibration and units as a versioned, CRC checked blob
+    int    saveConfig(LSM9DS1Storage& storage);
+    int    loadConfig(LSM9DS1Storage& storage);
+    size_t serializeConfig(uint8_t* data, size_t length);        // Return size of the blob, 0 on failure
+    int    deserializeConfig(const uint8_t* data, size_t length); // Nothing is changed when the blob is invalid
+
+    // Bus error recovery and sensor health
+    // A failed transfer clocks out the bus, restarts Wire and rewrites the chip settings, then retries
+    // once. One attempt takes about 4 ms at 100 kHz. Automatic recoveries starting within recoveryTimeout
+    // of each other share that budget, and the deadline is checked before every transfer, so the worst
+    // stall of one read call is recoveryTimeout plus one transfer (about 0.5 ms at 100 kHz).
+    unsigned long recoveryTimeout = LSM9DS1_RECOVERY_TIMEOUT;  // µs, 0 = no automatic recovery
+    uint16_t stuckLimit = 50;              // identical consecutive samples before a sensor counts as stuck
+    LSM9DS1Health health = {0,0,0,0,0,0};  // counters since begin() or resetHealth()
+    int   lastError();                     // LSM9DS1_ERROR_xxx of the last transfer
+    int   healthStatus();                  // LSM9DS1_HEALTH_xxx bits, 0 = healthy
+    void  resetHealth();
+    int   recoverBus();                    // Return 1 when the chip answers again. Own budget, also when recoveryTimeout = 0
+    void  setBusPins(uint8_t sda, uint8_t scl); // Pins used to clock out a stuck bus
+
     // Controls whether a FIFO is continuously filled, or a single reading is stored.
     // Defaults to one-shot.
     void setContinuousMode();
     void setOneShotMode();
-    int getOperationalMode(); //0=off , 1= Accel only , 2= Gyro +Accel
+    int getOperationalMode(); //0=off , 1= Accel only , 2= Gyro +Accel, -1= bus error
     // Accelerometer
     float accelOffset[3] = {0,0,0}; // zero point offset correction factor for calibration
     float accelSlope[3] = {1,1,1};  // slope correction factor for calibration
     float accelUnit = GRAVITY;      //  GRAVITY   OR  METERPERSECOND2 
     virtual int   readAccel(float& x, float& y, float& z); // Return calibrated data in unit of choise G or m/s2.
     virtual int   readRawAccel(float& x, float& y, float& z); // Return uncalibrated results  
+    virtual int   convertAccel(const int16_t* raw, size_t count, float* x, float* y, float* z); // count raw xyz triples -> calibrated x[], y[], z[]
     virtual int   accelAvailable(); // Number of samples in the FIFO.
     virtual void  setAccelOffset(float x, float y, float z);  //Store zero-point measurements as offset
     virtual void  setAccelSlope(float x, float y, float z);   //Store measurements as slope
@@ -100,6 +164,7 @@ class LSM9DS1Class {
     float gyroUnit = DEGREEPERSECOND;   // DEGREEPERSECOND  RADIANSPERSECOND REVSPERMINUTE REVSPERSECOND
     virtual int   readGyro(float& x, float& y, float& z); // Return calibrated data in in unit of choise °/s or rad/s.
     virtual int   readRawGyro(float& x, float& y, float& z); // Return uncalibrated results 
+    virtual int   convertGyro(const int16_t* raw, size_t count, float* x, float* y, float* z); // count raw xyz triples -> calibrated x[], y[], z[]
     virtual int   gyroAvailable(); 		// Number of samples in the FIFO.
     virtual void  setGyroOffset(float x, float y, float z);  //Store zero-point measurements as offset
     virtual void  setGyroSlope(float x, float y, float z);   //Store measurements as slope
@@ -116,11 +181,17 @@ class LSM9DS1Class {
     float magnetUnit = MICROTESLA;  //  GAUSS,  MICROTESLA NANOTESLA
     virtual int   readMagnet(float& x, float& y, float& z); // Return calibrated data in unit of choise µT , nT or G 
     virtual int   readRawMagnet(float& x, float& y, float& z); // Return uncalibrated results 
+    virtual int   convertMagnet(const int16_t* raw, size_t count, float* x, float* y, float* z); // count raw xyz triples -> calibrated x[], y[], z[]
     virtual int   magnetAvailable(); // Number of samples in the FIFO.
     virtual void  setMagnetOffset(float x, float y, float z);  //Store zero-point measurements as offset
     virtual void  setMagnetSlope(float x, float y, float z);   //Store measurements as slope
-    virtual int   setMagnetODR(uint8_t range); // Sampling rate (0..8)->{0.625,1.25,2.5,5.0,10,20,40,80,400}Hz
-    virtual float getMagnetODR(); // Sampling rate of the sensor in Hz.
+    virtual int   setMagnetODR(uint8_t range); // Sampling rate (0..7)->{0.625,1.25,2.5,5.0,10,20,40,80}Hz, 8=MAGNET_FAST_ODR
+    virtual float getMagnetODR(); // Sampling rate of the sensor in Hz. Measured, except nominal in FAST_ODR
+    virtual int   setMagnetPerformance(uint8_t xy, uint8_t z); // MAGNET_LOW_POWER .. MAGNET_ULTRA_HIGH for X,Y and for Z
+    virtual int   getMagnetPerformance(uint8_t& xy, uint8_t& z);
+    virtual int   setMagnetFastODR(uint8_t mode); // FAST_ODR with mode on all axes: 0:1000Hz 1:560Hz 2:300Hz 3:155Hz
+    virtual float measureMagnetNoise(uint16_t samples); // rms noise in magnetUnit, keep the board still. ~1.2 ms per sample at 100 kHz
+    virtual int   setMagnetFastestMode(float maxNoise); // Fastest FAST_ODR mode with noise <= maxNoise, return mode, or -1 with the previous mode kept
     virtual int   setMagnetFS(uint8_t range); // 0=±400.0; 1=±800.0; 2=±1200.0 , 3=±1600.0  (µT)
     virtual float getMagnetFS(); //  get chip's full scale setting  
 
@@ -130,6 +201,27 @@ class LSM9DS1Class {
     float gyroODR;						// Stores the actual value of Output Data Rate
     float magnetODR;                    // Stores the actual value of Output Data Rate
     bool continuousMode;
+    int  resetChip();
+    uint8_t sdaPin, sclPin;
+    uint8_t error;
+    bool recovering;
+    unsigned long recoveryStart;           // start of the current recovery budget, 0 = none
+    unsigned long recoveryBudget;          // length of the current recovery budget in µs
+    int  recoveryExpired();
+    int  autoRecover();
+    int  recover();
+    uint8_t shadowRegs[8];                 // last values written to the control registers, for recovery
+    int16_t lastSample[3][3];
+    uint16_t sameCount[3];
+    uint8_t saturated;
+    void busError(uint8_t code);
+    void clockOutBus();
+    int  restoreRegisters();
+    int  shadowIndex(uint8_t slaveAddress, uint8_t address);
+    void checkSample(int sensor, const int16_t data[3]);
+    int  modifyRegister(uint8_t slaveAddress, uint8_t address, uint8_t keep, uint8_t value);
+    static int validConfig(const uint8_t* data, size_t length);
+    static uint16_t crc16(const uint8_t* data, size_t length);
     void measureODRcombined();
     float measureAccelGyroODR();
     float measureMagnetODR(unsigned long duration);
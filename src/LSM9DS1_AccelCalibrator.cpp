@@ -0,0 +1,181 @@
+/*
+  This file is part of the Arduino_LSM9DS1 library.
+
+  Streaming six-position least squares accelerometer calibration.
+  See LSM9DS1_AccelCalibrator.h for the model and usage.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+*/
+
+#include "LSM9DS1_AccelCalibrator.h"
+#include <math.h>
+
+#ifdef ARDUINO
+#include "LSM9DS1.h"
+#endif
+
+LSM9DS1AccelCalibrator::LSM9DS1AccelCalibrator()
+{
+  reset();
+}
+
+void LSM9DS1AccelCalibrator::reset()
+{ winCount = 0;
+  for (int i = 0; i < 3; i++) { winSum[i] = 0; winSumSq[i] = 0; }
+  for (int o = 0; o < 6; o++)
+  { orientCount[o] = 0;
+    for (int i = 0; i < 3; i++) orientSum[o][i] = 0;
+  }
+}
+
+// Stillness is judged per window of windowSamples samples. The running sums are kept relative
+// to the first sample of the window, so the variance does not suffer from float cancellation.
+int LSM9DS1AccelCalibrator::addSample(float x, float y, float z)
+{ float v[3] = {x, y, z};
+  if (isnan(x) || isnan(y) || isnan(z)) { winCount = 0; return 0; }
+  if (winCount == 0)
+    for (int i = 0; i < 3; i++) { winFirst[i] = v[i]; winSum[i] = 0; winSumSq[i] = 0; }
+  for (int i = 0; i < 3; i++)
+  { float d = v[i] - winFirst[i];
+    winSum[i] += d;
+    winSumSq[i] += d * d;
+  }
+  if (++winCount < windowSamples) return 0;
+
+  float mean[3];
+  bool still = true;
+  for (int i = 0; i < 3; i++)
+  { float m = winSum[i] / winCount;
+    if (winSumSq[i] / winCount - m * m > stillVariance) still = false;
+    mean[i] = winFirst[i] + m;
+  }
+  winCount = 0;
+  if (!still) return 0;
+
+  int o = classify(mean);
+  if (o < 0 || orientCount[o] >= windowsPerOrientation) return 0;
+  for (int i = 0; i < 3; i++) orientSum[o][i] += mean[i];
+  orientCount[o]++;
+  return 1;
+}
+
+// Returns the orientation 0..5 (X+ Y+ Z+ X- Y- Z-) or -1 when the board is too oblique
+// or the magnitude is too far from 1 g to be a rest position.
+int LSM9DS1AccelCalibrator::classify(const float mean[3])
+{ float norm = sqrt(mean[0] * mean[0] + mean[1] * mean[1] + mean[2] * mean[2]);
+  if (fabs(norm - 1.0) > gravityTolerance) return -1;
+  int axis = 0;
+  for (int i = 1; i < 3; i++) if (fabs(mean[i]) > fabs(mean[axis])) axis = i;
+  float offAxis = 0;
+  for (int i = 0; i < 3; i++) if (i != axis) offAxis += mean[i] * mean[i];
+  if (sqrt(offAxis) / fabs(mean[axis]) >= axisCriterion) return -1;
+  return mean[axis] > 0 ? axis : axis + 3;
+}
+
+int LSM9DS1AccelCalibrator::orientationMask()
+{ int mask = 0;
+  for (int o = 0; o < 6; o++) if (orientCount[o] >= windowsPerOrientation) mask |= 1 << o;
+  return mask;
+}
+
+int LSM9DS1AccelCalibrator::orientationCount()
+{ int n = 0;
+  int mask = orientationMask();
+  for (int o = 0; o < 6; o++) if (mask & (1 << o)) n++;
+  return n;
+}
+
+// Solvable as soon as each axis has been seen at least once and four orientations are done.
+int LSM9DS1AccelCalibrator::isReady()
+{ int mask = orientationMask();
+  for (int i = 0; i < 3; i++) if (!(mask & (0b1001 << i))) return 0;
+  return orientationCount() >= 4;
+}
+
+int LSM9DS1AccelCalibrator::isComplete()
+{ return orientationMask() == 0b00111111;
+}
+
+// Least squares fit of raw = C * g + b over the measured orientations.
+// Every orientation contributes the row [g 1] with g = +-1 g along its axis, so the normal
+// equations are a 4x4 system shared by the three output axes.
+int LSM9DS1AccelCalibrator::solve()
+{ if (!isReady()) return 0;
+  int mask = orientationMask();
+  float a[4][7] = {{0}};            // [X'X | X'y0 X'y1 X'y2]
+  for (int o = 0; o < 6; o++)
+  { if (!(mask & (1 << o))) continue;
+    float row[4] = {0, 0, 0, 1};
+    row[o % 3] = o < 3 ? 1 : -1;
+    for (int r = 0; r < 4; r++)
+    { for (int c = 0; c < 4; c++) a[r][c] += row[r] * row[c];
+      for (int k = 0; k < 3; k++) a[r][4 + k] += row[r] * orientSum[o][k] / orientCount[o];
+    }
+  }
+  // Gauss-Jordan elimination with partial pivoting
+  for (int c = 0; c < 4; c++)
+  { int p = c;
+    for (int r = c + 1; r < 4; r++) if (fabs(a[r][c]) > fabs(a[p][c])) p = r;
+    if (fabs(a[p][c]) < 1e-6) return 0;
+    if (p != c) for (int j = 0; j < 7; j++) { float t = a[c][j]; a[c][j] = a[p][j]; a[p][j] = t; }
+    for (int r = 0; r < 4; r++)
+    { if (r == c) continue;
+      float f = a[r][c] / a[c][c];
+      for (int j = c; j < 7; j++) a[r][j] -= f * a[c][j];
+    }
+  }
+  float C[3][3], b[3];
+  for (int k = 0; k < 3; k++)
+  { for (int i = 0; i < 3; i++) C[k][i] = a[i][4 + k] / a[i][i];
+    b[k] = a[3][4 + k] / a[3][3];
+  }
+  // M = inverse(C) by cofactors
+  float det = C[0][0] * (C[1][1] * C[2][2] - C[1][2] * C[2][1])
+            - C[0][1] * (C[1][0] * C[2][2] - C[1][2] * C[2][0])
+            + C[0][2] * (C[1][0] * C[2][1] - C[1][1] * C[2][0]);
+  if (fabs(det) < 1e-6) return 0;
+  for (int r = 0; r < 3; r++)
+    for (int c = 0; c < 3; c++)
+    { int r1 = (c + 1) % 3, r2 = (c + 2) % 3, c1 = (r + 1) % 3, c2 = (r + 2) % 3;
+      matrix[r][c] = (C[r1][c1] * C[r2][c2] - C[r1][c2] * C[r2][c1]) / det;
+    }
+  for (int k = 0; k < 3; k++) bias[k] = b[k];
+
+  float sumSq = 0;
+  int n = 0;
+  for (int o = 0; o < 6; o++)
+  { if (!(mask & (1 << o))) continue;
+    float s = o < 3 ? 1 : -1;
+    for (int k = 0; k < 3; k++)
+    { float e = orientSum[o][k] / orientCount[o] - (C[k][o % 3] * s + b[k]);
+      sumSq += e * e;
+      n++;
+    }
+  }
+  residual = sqrt(sumSq / n);
+  return 1;
+}
+
+int LSM9DS1AccelCalibrator::correct(float& x, float& y, float& z)
+{ float d[3] = {x - bias[0], y - bias[1], z - bias[2]};
+  x = matrix[0][0] * d[0] + matrix[0][1] * d[1] + matrix[0][2] * d[2];
+  y = matrix[1][0] * d[0] + matrix[1][1] * d[1] + matrix[1][2] * d[2];
+  z = matrix[2][0] * d[0] + matrix[2][1] * d[1] + matrix[2][2] * d[2];
+  return 1;
+}
+
+#ifdef ARDUINO
+// The library applies   Unit * Slope * (raw - Offset)   per axis, so only the diagonal
+// of M can be used there. Use correct() on raw data when the cross-axis terms matter.
+int LSM9DS1AccelCalibrator::applyTo(LSM9DS1Class& imu)
+{ for (int i = 0; i < 3; i++)
+  { if (matrix[i][i] == 0) return 0;
+    imu.accelOffset[i] = bias[i];
+    imu.accelSlope[i] = matrix[i][i];
+  }
+  return 1;
+}
+#endif
@@ -0,0 +1,68 @@
+/*
+  This file is part of the Arduino_LSM9DS1 library.
+
+  Streaming six-position accelerometer calibration.
+  Feed raw accelerometer samples (IMU.readRawAccel) one at a time. The calibrator
+  detects on its own when the board is lying still in one of the six axis-up/axis-down
+  orientations, averages those periods, and solves for bias, scale and cross-axis terms
+  by least squares.  Memory use is constant: no sample buffers are kept.
+
+  Model:   raw = C * g + b     g = true acceleration (1 g along one axis when at rest)
+           g   = M * (raw - b)  with M = inverse(C)
+
+  The class does not depend on Arduino.h, so it can be compiled and tested on a PC
+  with synthetic data.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+*/
+
+#ifndef LSM9DS1_ACCEL_CALIBRATOR_H
+#define LSM9DS1_ACCEL_CALIBRATOR_H
+
+#include <stdint.h>
+
+class LSM9DS1Class;
+
+class LSM9DS1AccelCalibrator {
+  public:
+    LSM9DS1AccelCalibrator();
+
+    void  reset();
+    int   addSample(float x, float y, float z); // raw g; returns 1 when a still period was accepted
+    int   orientationMask();  // bit 0..2 = X+ Y+ Z+ ; bit 3..5 = X- Y- Z-  (same as the DIY sketch)
+    int   orientationCount(); // number of orientations measured (0..6)
+    int   isReady();          // 1 when enough orientations are covered for a solution
+    int   isComplete();       // 1 when all six orientations are covered
+    int   solve();            // least squares fit, returns 1 on success
+    int   correct(float& x, float& y, float& z); // apply full (cross-axis) calibration to raw g
+    int   applyTo(LSM9DS1Class& imu);             // copy offset and diagonal slope into the library
+
+    // Settings, may be changed before feeding samples
+    uint16_t windowSamples = 25;          // samples per stillness window (~0.2s at 119Hz)
+    uint8_t  windowsPerOrientation = 4;   // still windows averaged per orientation
+    float    stillVariance = 0.0004;      // max variance per axis in g^2 (0.02 g rms)
+    float    axisCriterion = 0.1;         // max off-axis / on-axis ratio, as in the DIY sketch
+    float    gravityTolerance = 0.25;     // max deviation of |raw| from 1 g
+
+    // Results, valid after solve()
+    float bias[3] = {0,0,0};                        // b, zero point offset in g
+    float matrix[3][3] = {{1,0,0},{0,1,0},{0,0,1}}; // M, scale and cross-axis correction
+    float residual = 0;                             // rms fit error in g
+
+  private:
+    // current stillness window
+    uint16_t winCount;
+    float winFirst[3];
+    float winSum[3];
+    float winSumSq[3];
+    // per orientation average of accepted windows
+    uint8_t orientCount[6];
+    float orientSum[6][3];
+
+    int  classify(const float mean[3]);
+};
+
+#endif
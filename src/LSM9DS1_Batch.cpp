@@ -0,0 +1,27 @@
+/*
+  This file is part of the Arduino_LSM9DS1 library.
+
+  Batch conversion of raw sensor samples, see LSM9DS1_Batch.h
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+*/
+
+#include "LSM9DS1_Batch.h"
+
+// One pass, one multiply-add per value and no branches, so the compiler can keep gain and bias
+// in registers and vectorize the loop where the target allows it. On the Cortex-M4 this is one
+// int to float conversion and one multiply-add per value.
+void LSM9DS1ConvertBatch(const int16_t* raw, size_t count, const float gain[3], const float bias[3],
+                         float* x, float* y, float* z)
+{ const float gx = gain[0], gy = gain[1], gz = gain[2];
+  const float bx = bias[0], by = bias[1], bz = bias[2];
+  for (size_t i = 0; i < count; i++)
+  { x[i] = gx * raw[0] + bx;
+    y[i] = gy * raw[1] + by;
+    z[i] = gz * raw[2] + bz;
+    raw += 3;
+  }
+}
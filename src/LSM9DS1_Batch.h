@@ -0,0 +1,27 @@
+/*
+  This file is part of the Arduino_LSM9DS1 library.
+
+  Batch conversion of raw sensor samples, e.g. drained from the FIFO.
+  Input is an array of count raw int16 triples x0 y0 z0 x1 y1 z1 ..., output is one float array
+  per axis (structure of arrays):     out[axis][i] = gain[axis] * raw[3*i+axis] + bias[axis]
+  IMU.convertAccel(), convertGyro() and convertMagnet() compute gain and bias from the full scale,
+  unit, slope and offset, so the result equals readAccel(), readGyro() and readMagnet().
+
+  The conversion is a single portable loop; it does not depend on Arduino.h.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+*/
+
+#ifndef LSM9DS1_BATCH_H
+#define LSM9DS1_BATCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+void LSM9DS1ConvertBatch(const int16_t* raw, size_t count, const float gain[3], const float bias[3],
+                         float* x, float* y, float* z);
+
+#endif
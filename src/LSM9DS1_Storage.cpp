@@ -0,0 +1,37 @@
+/*
+  This file is part of the Arduino_LSM9DS1 library.
+
+  File-backed LSM9DS1Storage for builds on a PC.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+*/
+
+#include "LSM9DS1_Storage.h"
+
+#ifndef ARDUINO
+#include <stdio.h>
+
+LSM9DS1FileStorage::LSM9DS1FileStorage(const char* path) :
+  _path(path)
+{
+}
+
+size_t LSM9DS1FileStorage::read(uint8_t* data, size_t length)
+{ FILE* f = fopen(_path, "rb");
+  if (!f) return 0;
+  size_t n = fread(data, 1, length, f);
+  fclose(f);
+  return n;
+}
+
+size_t LSM9DS1FileStorage::write(const uint8_t* data, size_t length)
+{ FILE* f = fopen(_path, "wb");
+  if (!f) return 0;
+  size_t n = fwrite(data, 1, length, f);
+  if (fclose(f) != 0) return 0;
+  return n;
+}
+#endif
@@ -0,0 +1,40 @@
+/*
+  This file is part of the Arduino_LSM9DS1 library.
+
+  Minimal non-volatile storage interface for the configuration and calibration blob
+  written by IMU.saveConfig() and read back by IMU.begin(storage) / IMU.loadConfig().
+  Implement read() and write() on top of EEPROM, flash, an SD card file, etc.
+  A file-backed implementation is included for builds on a PC.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+*/
+
+#ifndef LSM9DS1_STORAGE_H
+#define LSM9DS1_STORAGE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+class LSM9DS1Storage {
+  public:
+    virtual ~LSM9DS1Storage() {}
+    virtual size_t read(uint8_t* data, size_t length) = 0;        // Return number of bytes read
+    virtual size_t write(const uint8_t* data, size_t length) = 0; // Return number of bytes written
+};
+
+#ifndef ARDUINO
+class LSM9DS1FileStorage : public LSM9DS1Storage {
+  public:
+    LSM9DS1FileStorage(const char* path);
+    virtual size_t read(uint8_t* data, size_t length);
+    virtual size_t write(const uint8_t* data, size_t length);
+
+  private:
+    const char* _path;
+};
+#endif
+
+#endif